@@ -0,0 +1,20 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+
+// Boot phases, in the order they are expected to happen
+enum BOOT_PHASES {
+    BOOT_RESET = 0,         // Timer start, taken as 0
+    BOOT_CLOCKS,            // Runtime init (clocks, PLLs) done, entered main()
+    BOOT_USB_INIT,          // tusb_init() returned, device is attached to the bus
+    BOOT_USB_CONFIGURED,    // Host set the configuration (tud_mount_cb)
+    BOOT_FIRST_REPORT,      // First HID report handed to the stack
+    BOOT_PHASE_MAX
+};
+
+void bootMark(enum BOOT_PHASES phase);
+void bootReport(void);
+
+#endif
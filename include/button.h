@@ -0,0 +1,15 @@
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+
+struct ButtonEdge {
+    uint32_t time_us;
+    bool pressed;
+};
+
+void buttonInit(uint gpio, uint32_t debounce_us);
+bool buttonGetEdge(struct ButtonEdge *edge);
+
+#endif
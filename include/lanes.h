@@ -0,0 +1,53 @@
+#ifndef LANES_H
+#define LANES_H
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "pico/util/queue.h"
+#include "tusb.h"
+#include "usb_descriptors.h"
+#include "utils.h"
+
+#define ORDERED_LANE_SIZE 16
+#define MOTION_LANE_SIZE 8
+
+// Lanes of HID events waiting to be sent to the host, one set per HID interface
+//      Ordered: Keyboard, consumer and mouse button changes. Never dropped or merged, a full lane is reported back to the producer.
+//      Motion: Relative motion and absolute positions, pointer interface only. Merged into the newest entry or dropped when full.
+// Every event gets a sequence number. Within an interface events go out in sequence order, so a
+// button release can't overtake the motion it belongs to. Across interfaces only ordered events
+// wait for older ordered events to reach the host, so e.g. the middle button is never pressed
+// before CTRL, while motion and unrelated keyboard reports go out in the same frame.
+// Not interrupt safe, producers and consumer all run in the main loop.
+struct HIDLanes {
+    queue_t ordered[HID_INSTANCE_TOTAL];
+    struct HIDEvent motion[MOTION_LANE_SIZE];
+    uint8_t motion_head;
+    uint8_t motion_count;
+
+    uint32_t next_seq;
+    // Newest ordered event queued for the pointer interface
+    uint32_t last_ordered_seq;
+    // Mouse buttons as of the newest queued mouse event
+    uint8_t mouse_keys;
+
+    // Ordered event handed to an interface that may not have reached the host yet
+    bool inflight[HID_INSTANCE_TOTAL];
+    uint32_t inflight_seq[HID_INSTANCE_TOTAL];
+
+    // Counters
+    uint32_t ordered_full;
+    uint32_t motion_merged;
+    uint32_t motion_dropped;
+};
+
+void initHIDLanes(struct HIDLanes *lanes);
+void clearHIDLanes(struct HIDLanes *lanes);
+bool addHIDEvent(struct HIDLanes *lanes, struct HIDEvent *event);
+bool reserveOrdered(struct HIDLanes *lanes, uint8_t instance, uint8_t count);
+bool peekHIDEvent(struct HIDLanes *lanes, uint8_t instance, struct HIDEvent *event);
+bool takeHIDEvent(struct HIDLanes *lanes, uint8_t instance, struct HIDEvent *event);
+uint8_t hidInstance(struct HIDEvent *event);
+void reportHIDLanes(struct HIDLanes *lanes);
+
+#endif
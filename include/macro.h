@@ -0,0 +1,30 @@
+#ifndef MACRO_H
+#define MACRO_H
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "utils.h"
+
+struct MacroStep {
+    enum { MACRO_KEYBOARD, MACRO_CONSUMER } type;
+    uint8_t modifiers;
+    uint8_t keys[6];
+    uint16_t usage;
+};
+
+// A precompiled sequence of reports, keep these `const` so they stay in flash
+struct Macro {
+    const struct MacroStep *steps;
+    uint8_t count;
+};
+
+#define MACRO(steps) { (steps), sizeof(steps) / sizeof((steps)[0]) }
+
+bool playMacro(const struct Macro *macro);
+void stopMacro(void);
+bool nextMacroEvent(struct HIDEvent *event);
+void advanceMacro(void);
+void setMacroBase(struct KeyboardEvent *keyboard);
+void reportMacros(void);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef REPORTS_H
+#define REPORTS_H
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "utils.h"
+
+enum SUBMIT_RESULTS { SUBMIT_SENT, SUBMIT_SUPPRESSED, SUBMIT_FAILED };
+
+void resetReports(void);
+enum SUBMIT_RESULTS submitHIDEvent(uint8_t instance, struct HIDEvent *event);
+bool repeatIdleReports(uint8_t instance);
+void setIdleRate(uint8_t instance, uint8_t rate);
+uint16_t getShadowReport(uint8_t instance, uint8_t report_id, uint8_t *buffer, uint16_t reqlen);
+void reportHIDReports(void);
+
+#endif
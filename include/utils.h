@@ -14,16 +14,34 @@ struct MouseEvent {
     uint8_t keys;
     uint8_t x;
     uint8_t y;
+    uint8_t wheel;
+    uint8_t pan;
+};
+
+struct GamepadEvent {
+    int16_t x;
+    int16_t y;
+};
+
+struct ConsumerEvent {
+    uint16_t usage;
 };
 
 struct HIDEvent {
-    enum { EVENT_KEYBOARD, EVENT_MOUSE } type;
+    enum { EVENT_KEYBOARD, EVENT_MOUSE, EVENT_GAMEPAD, EVENT_CONSUMER } type;
     struct MouseEvent mouse_data;
     struct KeyboardEvent keyboard_data;
+    struct GamepadEvent gamepad_data;
+    struct ConsumerEvent consumer_data;
+    // Filled in when the event is added to the lanes
+    uint32_t seq;
 };
 
-bool sendMouseEvent(queue_t *queue, uint8_t keys, uint8_t x, uint8_t y);
-bool sendKeyboardEvent(queue_t *queue, uint8_t modifiers, uint8_t keys[6]);
+struct HIDLanes;
+
+bool sendMouseEvent(struct HIDLanes *lanes, uint8_t keys, uint8_t x, uint8_t y, uint8_t wheel, uint8_t pan);
+bool sendKeyboardEvent(struct HIDLanes *lanes, uint8_t modifiers, uint8_t keys[6]);
+bool sendGamepadEvent(struct HIDLanes *lanes, int16_t x, int16_t y);
 void logMessage(char* str);
 void logLine(char* str);
 uint16_t readADC(uint8_t num);
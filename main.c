@@ -4,27 +4,78 @@
 #include "tusb.h"
 #include "usb_descriptors.h"
 #include "utils.h"
+#include "boot.h"
+#include "button.h"
+#include "lanes.h"
+#include "reports.h"
+#include "macro.h"
 #include "hardware/adc.h"
 
 #define LED_PIN PICO_DEFAULT_LED_PIN
-#define NUM_SMS 4
+#define NUM_SMS 6
 #define DEADZONE 50
 #define ADC0 26
 #define ADC1 27
 #define JS_BUTTON 15
+#define JS_DEBOUNCE_US 5000
+#define LONG_PRESS_US 600000
+#define DOUBLE_CLICK_US 300000
+// Raw joystick units per high resolution wheel count while zooming
+#define ZOOM_DIVISOR 640
+// Raw joystick units of change needed before a new gamepad report is sent
+#define GAMEPAD_NOISE 4
+// Consumer Control usage AC Zoom, mapped to zoom reset by most hosts
+#define CONSUMER_AC_ZOOM 0x022F
 
 // ***** Global SM Variables *****
 int16_t js_x;
 int16_t js_y;
-bool js_button;
+int16_t js_raw_x;
+int16_t js_raw_y;
 enum MODES {
     MODE_PAN = 0,
     MODE_ROTATE,
+    MODE_ZOOM,
+    MODE_GAMEPAD,
     MODE_MAX
 } mode;
+// Resolution Multiplier feature report as last set by the host
+// Bits 0-1: Wheel, Bits 2-3: Pan
+uint8_t res_multiplier;
 // *******************************
 
-queue_t queue;
+struct HIDLanes lanes;
+
+// ***** Macros *****
+// Fit the model to the view (F)
+const struct MacroStep macro_fit_steps[] = {
+    { .type = MACRO_KEYBOARD, .keys = { HID_KEY_F } },
+    { .type = MACRO_KEYBOARD }
+};
+// Isometric view (CTRL+7)
+const struct MacroStep macro_iso_steps[] = {
+    { .type = MACRO_KEYBOARD, .modifiers = KEYBOARD_MODIFIER_LEFTCTRL },
+    { .type = MACRO_KEYBOARD, .modifiers = KEYBOARD_MODIFIER_LEFTCTRL, .keys = { HID_KEY_7 } },
+    { .type = MACRO_KEYBOARD, .modifiers = KEYBOARD_MODIFIER_LEFTCTRL },
+    { .type = MACRO_KEYBOARD }
+};
+const struct MacroStep macro_zoom_reset_steps[] = {
+    { .type = MACRO_CONSUMER, .usage = CONSUMER_AC_ZOOM },
+    { .type = MACRO_CONSUMER }
+};
+const struct MacroStep macro_play_pause_steps[] = {
+    { .type = MACRO_CONSUMER, .usage = HID_USAGE_CONSUMER_PLAY_PAUSE },
+    { .type = MACRO_CONSUMER }
+};
+
+// Macro played on a double click, per mode
+const struct Macro mode_macros[MODE_MAX] = {
+    [MODE_PAN] = MACRO(macro_fit_steps),
+    [MODE_ROTATE] = MACRO(macro_iso_steps),
+    [MODE_ZOOM] = MACRO(macro_zoom_reset_steps),
+    [MODE_GAMEPAD] = MACRO(macro_play_pause_steps)
+};
+// ******************
 
 void init() {
     stdio_init_all();
@@ -38,12 +89,10 @@ void init() {
     adc_init();
     adc_gpio_init(ADC0);
     adc_gpio_init(ADC1);
-    gpio_init(JS_BUTTON);
-    gpio_set_dir(JS_BUTTON, GPIO_IN);
-    gpio_pull_up(JS_BUTTON);
+    buttonInit(JS_BUTTON, JS_DEBOUNCE_US);
 
-    // Initialize queue for mouse events
-    queue_init(&queue, sizeof(struct HIDEvent), 10);
+    // Initialize lanes for HID events
+    initHIDLanes(&lanes);
 
     mode = MODE_PAN;
 }
@@ -54,6 +103,7 @@ void init() {
 // *****
 enum LED_STATES { LED_START, LED_TOGGLE };
 int LED_Tick(int cur_state) {
+    static uint8_t blink = 0;
     switch (cur_state) {
         case LED_START:
             gpio_put(LED_PIN, 0);
@@ -68,8 +118,15 @@ int LED_Tick(int cur_state) {
         case LED_START:
             break;
         case LED_TOGGLE:
-            // gpio_put(LED_PIN, !gpio_get(LED_PIN));
-            gpio_put(LED_PIN, mode == MODE_PAN);
+            // On for pan, off for rotate, blinking for zoom, slow blinking for gamepad
+            if (mode == MODE_ZOOM) {
+                gpio_put(LED_PIN, !gpio_get(LED_PIN));
+            } else if (mode == MODE_GAMEPAD) {
+                blink = (blink + 1) % 10;
+                gpio_put(LED_PIN, blink < 5);
+            } else {
+                gpio_put(LED_PIN, mode == MODE_PAN);
+            }
             break;
     }
 
@@ -111,13 +168,11 @@ int JS_Tick(int cur_state) {
                 raw_y = raw_y;
             }
 
+            js_raw_x = raw_x;
+            js_raw_y = raw_y;
             js_x = map(raw_x, -2048, 2048, -20, 20);
             js_y = map(raw_y, -2048, 2048, -20, 20);
 
-            // Button is pulled up, so make sure to invert the input to get
-            // the "logical" usage of button. 1 = pressed, 0 = unpressed
-            js_button = !gpio_get(JS_BUTTON);
-
             break;
     }
 
@@ -126,33 +181,71 @@ int JS_Tick(int cur_state) {
 
 // *****
 // Mode SM
-// Used joystick button to change mode
+// Classifies joystick button edges into gestures and acts on them
+//      Click: Switch to the next mode, as soon as the button is released
+//      Double Click: Undo the mode switch of the first click, so the gesture is mode neutral,
+//                    then play the mode's macro
+//      Long Press: Go back to MODE_PAN, fires while the button is still held
 // *****
-enum MD_STATES { MD_START, MD_WAIT, MD_HOLD, MD_TOGGLE };
+enum MD_STATES { MD_START, MD_WAIT, MD_HOLD, MD_LONG };
+enum GESTURES { GESTURE_NONE, GESTURE_CLICK, GESTURE_DOUBLE_CLICK, GESTURE_LONG_PRESS };
 int Mode_Tick(int cur_state) {
+    static uint32_t press_us;
+    static uint32_t click_us;
+    static bool click_pending = false;
+    static bool second_press = false;
+    static enum MODES click_mode;
+    enum GESTURES gesture = GESTURE_NONE;
+    struct ButtonEdge edge;
+
+    bool have_edge = buttonGetEdge(&edge);
+
     switch (cur_state) {
         case MD_START:
             cur_state = MD_WAIT;
             break;
         case MD_WAIT:
-            cur_state = (js_button == 1 ? MD_HOLD : MD_WAIT);
+            if (have_edge && edge.pressed) {
+                press_us = edge.time_us;
+                second_press = click_pending && (edge.time_us - click_us <= DOUBLE_CLICK_US);
+                cur_state = MD_HOLD;
+            }
             break;
         case MD_HOLD:
-            cur_state = (js_button? MD_HOLD : MD_TOGGLE);
+            if (have_edge && !edge.pressed) {
+                gesture = (second_press ? GESTURE_DOUBLE_CLICK : GESTURE_CLICK);
+                cur_state = MD_WAIT;
+            } else if (time_us_32() - press_us >= LONG_PRESS_US) {
+                gesture = GESTURE_LONG_PRESS;
+                cur_state = MD_LONG;
+            }
             break;
-        case MD_TOGGLE:
-            cur_state = MD_WAIT;
+        case MD_LONG:
+            // Swallow the release of a long press
+            if (have_edge && !edge.pressed) {
+                cur_state = MD_WAIT;
+            }
             break;
     }
 
-    switch (cur_state) {
-        case MD_WAIT:
-            break;
-        case MD_HOLD:
+    switch (gesture) {
+        case GESTURE_NONE:
             break;
-        case MD_TOGGLE:
+        case GESTURE_CLICK:
+            click_pending = true;
+            click_us = edge.time_us;
+            click_mode = mode;
             mode = (mode + 1) % (MODE_MAX);
             break;
+        case GESTURE_DOUBLE_CLICK:
+            click_pending = false;
+            mode = click_mode;
+            playMacro(&mode_macros[mode]);
+            break;
+        case GESTURE_LONG_PRESS:
+            click_pending = false;
+            mode = MODE_PAN;
+            break;
     }
 
     return cur_state;
@@ -160,39 +253,65 @@ int Mode_Tick(int cur_state) {
 
 // *****
 // Move SM
-// This adds the mouse movement event to the queue.
+// This adds the mouse movement event to the lanes.
 // A mouse movement should consist of a few different stages:
 //      Movement Preamble: The initial press keystrokes (eg send a SHIFT key so mouse movements pan instead of rotate)
 //      Movement Action: The actual mouse events
 //      Movement Epilogue: The release of the keystrokes sent in the preamble
 // *****
 enum MV_STATES { MV_START, MV_WAIT, MV_PREAMBLE, MV_ACTION, MV_EPILOGUE };
+
+// Zoom only follows the Y axis, and uses the raw value so slow zoom
+// isn't lost in the deadzone of the mapped value.
+// Gamepad mode reports absolute positions from Gamepad_Tick instead.
+bool Move_Active(enum MODES cur_mode) {
+    if (cur_mode == MODE_GAMEPAD) {
+        return false;
+    }
+    if (cur_mode == MODE_ZOOM) {
+        return js_raw_y != 0;
+    }
+    return js_x != 0 || js_y != 0;
+}
+
 int Move_Tick(int cur_state) {
     static uint8_t active_keys[6] = { 0, 0, 0, 0, 0 };
+    // Mode the current movement was started in, so the epilogue releases
+    // what the preamble pressed even if the mode changes mid movement
+    static enum MODES active_mode;
+    // Sub-count wheel movement carried over between ticks
+    static int32_t zoom_remainder;
+    // Whether the preamble/epilogue made it into the ordered lane, retried every tick until it does
+    static bool stage_sent;
+    int32_t zoom_step;
+    int32_t wheel;
+
     switch (cur_state) {
         case MV_START:
             cur_state = MV_WAIT;
             break;
         case MV_WAIT:
             // Wait for a movement that != 0
-            if (js_x != 0 || js_y != 0) {
+            if (Move_Active(mode)) {
+                active_mode = mode;
+                zoom_remainder = 0;
                 cur_state = MV_PREAMBLE;
             } else {
                 cur_state = MV_WAIT;
             }
             break;
         case MV_PREAMBLE:
-            cur_state = MV_ACTION;
+            cur_state = (stage_sent ? MV_ACTION : MV_PREAMBLE);
             break;
         case MV_ACTION:
-            if (js_x != 0 || js_y != 0) {
+            if (Move_Active(active_mode)) {
                 cur_state = MV_ACTION;
             } else {
                 cur_state = MV_EPILOGUE;
             }
             break;
         case MV_EPILOGUE:
-            cur_state = MV_WAIT;
+            cur_state = (stage_sent ? MV_WAIT : MV_EPILOGUE);
             break;
     }
 
@@ -202,20 +321,142 @@ int Move_Tick(int cur_state) {
         case MV_WAIT:
             break;
         case MV_PREAMBLE:
-            if (mode == MODE_PAN) {
-                // Press left shift
-                sendKeyboardEvent(&queue, KEYBOARD_MODIFIER_LEFTCTRL, active_keys);
+            stage_sent = true;
+            if (active_mode == MODE_PAN) {
+                // Press left ctrl
+                stage_sent = sendKeyboardEvent(&lanes, KEYBOARD_MODIFIER_LEFTCTRL, active_keys);
             }
             break;
         case MV_ACTION:
-            sendMouseEvent(&queue, MOUSE_BUTTON_MIDDLE, js_x, js_y);
+            if (active_mode == MODE_ZOOM) {
+                // Without the host enabling the Resolution Multiplier every wheel count is a full detent
+                zoom_step = ZOOM_DIVISOR * ((res_multiplier & 0x03) ? 1 : WHEEL_RES_MULTIPLIER);
+                // Pushing the stick up zooms in (wheel up)
+                zoom_remainder -= js_raw_y;
+                wheel = zoom_remainder / zoom_step;
+                if (wheel > 127) {
+                    wheel = 127;
+                } else if (wheel < -127) {
+                    wheel = -127;
+                }
+                // If the motion lane is backed up keep the counts for the next tick
+                if (wheel != 0 && sendMouseEvent(&lanes, 0x00, 0x00, 0x00, wheel, 0x00)) {
+                    zoom_remainder -= wheel * zoom_step;
+                }
+                if (zoom_remainder > 127 * zoom_step) {
+                    zoom_remainder = 127 * zoom_step;
+                } else if (zoom_remainder < -127 * zoom_step) {
+                    zoom_remainder = -127 * zoom_step;
+                }
+            } else {
+                sendMouseEvent(&lanes, MOUSE_BUTTON_MIDDLE, js_x, js_y, 0x00, 0x00);
+            }
             break;
         case MV_EPILOGUE:
-            if (mode == MODE_PAN) {
-                // Release left shift
-                sendKeyboardEvent(&queue, 0x00, active_keys);
+            // Both releases go in together or not at all. The mouse buttons are released
+            // first, so the host never sees the drag without the modifier.
+            stage_sent = reserveOrdered(&lanes, HID_INSTANCE_POINTER, 1)
+                && (active_mode != MODE_PAN || reserveOrdered(&lanes, HID_INSTANCE_KEYBOARD, 1));
+            if (stage_sent) {
+                sendMouseEvent(&lanes, 0x00, 0x00, 0x00, 0x00, 0x00);
+                if (active_mode == MODE_PAN) {
+                    // Release left ctrl
+                    sendKeyboardEvent(&lanes, 0x00, active_keys);
+                }
+            }
+            break;
+    }
+
+    return cur_state;
+}
+
+// *****
+// Gamepad SM
+// Reports the joystick as absolute gamepad axes at full ADC resolution while in MODE_GAMEPAD.
+// A report is only sent when the position changed, and the axes are centered when leaving the mode.
+// *****
+enum GP_STATES { GP_START, GP_IDLE, GP_ACTIVE };
+
+// Moves smaller than GAMEPAD_NOISE are ADC noise, except for coming back to center
+bool Gamepad_Changed(int16_t sent, int16_t cur) {
+    if (cur == sent) {
+        return false;
+    }
+    return cur == 0 || cur - sent > GAMEPAD_NOISE || sent - cur > GAMEPAD_NOISE;
+}
+
+int Gamepad_Tick(int cur_state) {
+    static int16_t sent_x = 0;
+    static int16_t sent_y = 0;
+    int16_t x = 0;
+    int16_t y = 0;
+
+    switch (cur_state) {
+        case GP_START:
+            cur_state = GP_IDLE;
+            break;
+        case GP_IDLE:
+            cur_state = (mode == MODE_GAMEPAD ? GP_ACTIVE : GP_IDLE);
+            break;
+        case GP_ACTIVE:
+            cur_state = (mode == MODE_GAMEPAD ? GP_ACTIVE : GP_IDLE);
+            break;
+    }
+
+    switch (cur_state) {
+        case GP_START:
+            break;
+        case GP_IDLE:
+            // Stay centered
+            break;
+        case GP_ACTIVE:
+            x = js_raw_x;
+            y = js_raw_y;
+            break;
+    }
+
+    if (Gamepad_Changed(sent_x, x) || Gamepad_Changed(sent_y, y)) {
+        // Only remember what actually made it into the lanes, so a dropped position is retried next tick
+        if (sendGamepadEvent(&lanes, x, y)) {
+            sent_x = x;
+            sent_y = y;
+        }
+    }
+
+    return cur_state;
+}
+
+// *****
+// Command SM
+// Reads single character commands from CDC
+//      b: Print boot phase timestamps
+//      s: Print HID lane, report suppression and macro counters
+// *****
+enum CMD_STATES { CMD_START, CMD_POLL };
+int CMD_Tick(int cur_state) {
+    switch (cur_state) {
+        case CMD_START:
+            cur_state = CMD_POLL;
+            break;
+        case CMD_POLL:
+            cur_state = CMD_POLL;
+            break;
+    }
+
+    switch (cur_state) {
+        case CMD_POLL:
+            while (tud_cdc_available()) {
+                switch (tud_cdc_read_char()) {
+                    case 'b':
+                        bootReport();
+                        break;
+                    case 's':
+                        reportHIDLanes(&lanes);
+                        reportHIDReports();
+                        reportMacros();
+                        break;
+                }
             }
-            sendMouseEvent(&queue, 0x00, 0x00, 0x00);
             break;
     }
 
@@ -230,10 +471,14 @@ struct TaskStruct {
 };
 
 int main() {
-    sleep_ms(1000);
+    bootMark(BOOT_CLOCKS);
 
-    init();
+    // Bring up USB first so the host can start enumerating while the
+    // rest of the board is initialized
     tusb_init();
+    bootMark(BOOT_USB_INIT);
+
+    init();
 
     struct TaskStruct tasks[NUM_SMS];
     // *** DONT FORGET TO MODIFY NUM_SMS ***
@@ -250,8 +495,8 @@ int main() {
     tasks[1].tick_fn = &JS_Tick;
     tasks[1].cur_state = JS_START;
 
-    // Poll Joystick Button
-    tasks[2].period_ms = 100;
+    // Joystick Button Gestures
+    tasks[2].period_ms = 1;
     tasks[2].last_ms = 0;
     tasks[2].tick_fn = &Mode_Tick;
     tasks[2].cur_state = MD_START;
@@ -262,6 +507,18 @@ int main() {
     tasks[3].tick_fn = &Move_Tick;
     tasks[3].cur_state = MV_START;
 
+    // CDC Commands
+    tasks[4].period_ms = 50;
+    tasks[4].last_ms = 0;
+    tasks[4].tick_fn = &CMD_Tick;
+    tasks[4].cur_state = CMD_START;
+
+    // Gamepad Axes
+    tasks[5].period_ms = 10;
+    tasks[5].last_ms = 0;
+    tasks[5].tick_fn = &Gamepad_Tick;
+    tasks[5].cur_state = GP_START;
+
     int32_t cur_ms;
     int32_t last_push = 0;
     char message[64];
@@ -276,44 +533,96 @@ int main() {
             
         }
 
-        // Process mouse movement items in the queue
-        // If ready to send HID data and queue has items to process
-        if (tud_hid_ready() && !queue_is_empty(&queue)) {
+        // Process HID events in the lanes
+        // Each HID interface has its own endpoint, so every interface that is ready to send gets its next item
+        for (uint8_t instance = 0; instance < HID_INSTANCE_TOTAL; instance++) {
             struct HIDEvent data;
-            bool item = queue_try_remove(&queue, &data);
+            enum SUBMIT_RESULTS result;
 
-            struct KeyboardEvent k_data = data.keyboard_data;
-            struct MouseEvent m_data = data.mouse_data;
+            if (!tud_hid_n_ready(instance)) {
+                continue;
+            }
 
-            if (item) {
-                cur_ms = to_ms_since_boot(get_absolute_time());
-                switch(data.type) {
-                    case EVENT_KEYBOARD:
-                        tud_hid_keyboard_report(REPORT_ID_KEYBOARD, k_data.modifiers, k_data.keys);
-                        break;
-                    case EVENT_MOUSE:
-                        tud_hid_mouse_report(REPORT_ID_MOUSE, m_data.keys, m_data.x, m_data.y, 0, 0);
-                        snprintf(message, 64, "Mouse: %i  X: %i  Y: %i\n", m_data.keys, m_data.x, m_data.y);
-                        logLine(message);
-                        break;
+            // Nothing queued, play the next macro step as soon as the keyboard interface
+            // is free, otherwise check if the host wants the current state repeated.
+            // A keyboard event waiting on the ordered barrier isn't passed by a macro step
+            if (!peekHIDEvent(&lanes, instance, &data)) {
+                if (instance == HID_INSTANCE_KEYBOARD && queue_is_empty(&lanes.ordered[HID_INSTANCE_KEYBOARD])
+                    && nextMacroEvent(&data)) {
+                    // A step the interface didn't take is tried again next time
+                    if (submitHIDEvent(instance, &data) != SUBMIT_FAILED) {
+                        advanceMacro();
+                    }
+                } else {
+                    repeatIdleReports(instance);
                 }
-                last_push = cur_ms;
+                continue;
+            }
+
+            // Lane keyboard reports and macro steps share one keyboard report, merge them
+            if (data.type == EVENT_KEYBOARD) {
+                setMacroBase(&data.keyboard_data);
             }
+
+            // Reports the host already has are dropped here. The event only leaves its
+            // lane once it was sent or suppressed, so a failed send is retried
+            result = submitHIDEvent(instance, &data);
+            if (result == SUBMIT_FAILED) {
+                continue;
+            }
+            takeHIDEvent(&lanes, instance, &data);
+            if (result == SUBMIT_SUPPRESSED) {
+                continue;
+            }
+
+            cur_ms = to_ms_since_boot(get_absolute_time());
+            if (data.type == EVENT_MOUSE) {
+                struct MouseEvent m_data = data.mouse_data;
+                snprintf(message, 64, "Mouse: %i  X: %i  Y: %i  W: %i\n", m_data.keys, m_data.x, m_data.y, m_data.wheel);
+                logLine(message);
+            }
+            bootMark(BOOT_FIRST_REPORT);
+            last_push = cur_ms;
         }
         tud_task();
     }
 }
 
+// Invoked when device is mounted (configured by the host)
+void tud_mount_cb(void) {
+  bootMark(BOOT_USB_CONFIGURED);
+}
+
+// Invoked when device is unmounted
+void tud_umount_cb(void) {
+  // Host has to enable high resolution scrolling again after re-enumerating
+  res_multiplier = 0;
+  // Nothing queued means anything to a host that is gone
+  clearHIDLanes(&lanes);
+  resetReports();
+  stopMacro();
+}
+
+// Invoked when received SET_IDLE request. return false will stall the request
+// Idle Rate = 0 : only send report if there is changes, i.e skip duplication
+// Idle Rate > 0 : skip duplication, but send at least 1 report every idle rate (in unit of 4 ms).
+bool tud_hid_set_idle_cb(uint8_t instance, uint8_t idle_rate) {
+  setIdleRate(instance, idle_rate);
+  return true;
+}
+
 // Invoked when received GET_REPORT control request
 // Application must fill buffer report's content and return its length.
 // Return zero will cause the stack to STALL request
 uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer, uint16_t reqlen) {
-  // TODO not Implemented
-  (void) instance;
-  (void) report_id;
-  (void) report_type;
-  (void) buffer;
-  (void) reqlen;
+  if (instance == HID_INSTANCE_POINTER && report_type == HID_REPORT_TYPE_FEATURE && report_id == REPORT_ID_MOUSE && reqlen >= 1) {
+    buffer[0] = res_multiplier;
+    return 1;
+  }
+
+  if (report_type == HID_REPORT_TYPE_INPUT) {
+    return getShadowReport(instance, report_id, buffer, reqlen);
+  }
 
   return 0;
 }
@@ -321,5 +630,13 @@ uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_t
 // Invoked when received SET_REPORT control request or
 // received data on OUT endpoint ( Report ID = 0, Type = 0 )
 void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const* buffer, uint16_t bufsize) {
-  (void) instance;
+  // Depending on the TinyUSB version the report ID may still be in front of the data
+  if (report_id != 0 && bufsize > 1 && buffer[0] == report_id) {
+    buffer++;
+    bufsize--;
+  }
+
+  if (instance == HID_INSTANCE_POINTER && report_type == HID_REPORT_TYPE_FEATURE && report_id == REPORT_ID_MOUSE && bufsize >= 1) {
+    res_multiplier = buffer[0];
+  }
 }
\ No newline at end of file
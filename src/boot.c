@@ -0,0 +1,51 @@
+#include "boot.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "utils.h"
+
+static const char* boot_names[BOOT_PHASE_MAX] = {
+    "reset",
+    "clocks",
+    "usb_init",
+    "usb_configured",
+    "first_report"
+};
+
+// The timer is brought out of reset by the runtime before clocks_init(),
+// so BOOT_RESET is 0 by definition.
+static uint32_t boot_us[BOOT_PHASE_MAX];
+static bool boot_reached[BOOT_PHASE_MAX] = { [BOOT_RESET] = true };
+
+/**
+ * @brief Records the current time for a boot phase.
+ * Only the first call per phase is kept, so it is safe to call from hot paths.
+ *
+ * @param phase The phase that was just reached
+ */
+void bootMark(enum BOOT_PHASES phase) {
+    if (phase >= BOOT_PHASE_MAX || boot_reached[phase]) {
+        return;
+    }
+    boot_us[phase] = time_us_32();
+    boot_reached[phase] = true;
+}
+
+/**
+ * @brief Writes the boot timeline to CDC, one phase per line.
+ * Each line has the absolute time since reset and the delta from the previous phase, in microseconds.
+ */
+void bootReport(void) {
+    char message[64];
+    uint32_t last_us = 0;
+
+    for (int i = 0; i < BOOT_PHASE_MAX; i++) {
+        if (!boot_reached[i]) {
+            snprintf(message, 64, "boot %-14s --", boot_names[i]);
+        } else {
+            snprintf(message, 64, "boot %-14s %8lu us  +%lu us", boot_names[i],
+                     (unsigned long) boot_us[i], (unsigned long) (boot_us[i] - last_us));
+            last_us = boot_us[i];
+        }
+        logLine(message);
+    }
+}
@@ -0,0 +1,94 @@
+#include "button.h"
+#include "pico/stdlib.h"
+#include "pico/util/queue.h"
+#include "hardware/sync.h"
+
+#define BUTTON_FIFO_SIZE 16
+
+static queue_t edge_queue;
+static uint button_gpio;
+static volatile uint32_t button_debounce_us;
+static volatile uint32_t last_edge_us;
+static volatile bool last_pressed;
+
+/**
+ * @brief GPIO interrupt handler, timestamps each debounced edge into the FIFO.
+ * Edges closer than the debounce time to the last accepted edge are treated as bounce.
+ * If the pin settles at a new level inside that window, buttonGetEdge picks it up afterwards.
+ */
+static void buttonIRQ(uint gpio, uint32_t events) {
+    (void) events;
+    if (gpio != button_gpio) {
+        return;
+    }
+
+    uint32_t now = time_us_32();
+    // Button is pulled up, so a low level means pressed
+    bool pressed = !gpio_get(gpio);
+
+    if (pressed == last_pressed || now - last_edge_us < button_debounce_us) {
+        return;
+    }
+
+    struct ButtonEdge edge = {
+        .time_us = now,
+        .pressed = pressed
+    };
+    // Only commit the new level once the edge is queued, so a full FIFO
+    // can't leave the consumer with a different idea of the button state
+    if (queue_try_add(&edge_queue, &edge)) {
+        last_pressed = pressed;
+        last_edge_us = now;
+    }
+}
+
+/**
+ * @brief Sets up a pulled up, active low button with edge interrupts on both edges.
+ *
+ * @param gpio The GPIO the button is connected to
+ * @param debounce_us Minimum time between two accepted edges
+ */
+void buttonInit(uint gpio, uint32_t debounce_us) {
+    button_gpio = gpio;
+    button_debounce_us = debounce_us;
+    queue_init(&edge_queue, sizeof(struct ButtonEdge), BUTTON_FIFO_SIZE);
+
+    gpio_init(gpio);
+    gpio_set_dir(gpio, GPIO_IN);
+    gpio_pull_up(gpio);
+
+    last_pressed = !gpio_get(gpio);
+    last_edge_us = time_us_32();
+    gpio_set_irq_enabled_with_callback(gpio, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true, &buttonIRQ);
+}
+
+/**
+ * @brief Takes the oldest edge out of the FIFO.
+ * With the FIFO empty and the debounce window over, the pin is sampled again, and an edge
+ * that was discarded as bounce (e.g. a release during the window) is made up for.
+ *
+ * @param edge Filled with the edge when one is available
+ * @return `true` when an edge was removed or made up, `false` otherwise
+ */
+bool buttonGetEdge(struct ButtonEdge *edge) {
+    if (queue_try_remove(&edge_queue, edge)) {
+        return true;
+    }
+
+    // Keep the IRQ from accepting an edge between the check and the update
+    uint32_t status = save_and_disable_interrupts();
+    uint32_t now = time_us_32();
+    bool pressed = !gpio_get(button_gpio);
+    bool missed = pressed != last_pressed && now - last_edge_us >= button_debounce_us;
+    if (missed) {
+        last_pressed = pressed;
+        last_edge_us = now;
+    }
+    restore_interrupts(status);
+
+    if (missed) {
+        edge->time_us = now;
+        edge->pressed = pressed;
+    }
+    return missed;
+}
@@ -0,0 +1,282 @@
+#include "lanes.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/util/queue.h"
+#include "tusb.h"
+
+void initHIDLanes(struct HIDLanes *lanes) {
+    for (int i = 0; i < HID_INSTANCE_TOTAL; i++) {
+        queue_init(&lanes->ordered[i], sizeof(struct HIDEvent), ORDERED_LANE_SIZE);
+        lanes->inflight[i] = false;
+    }
+    lanes->motion_head = 0;
+    lanes->motion_count = 0;
+    lanes->next_seq = 0;
+    lanes->last_ordered_seq = 0;
+    lanes->mouse_keys = 0;
+    lanes->ordered_full = 0;
+    lanes->motion_merged = 0;
+    lanes->motion_dropped = 0;
+}
+
+/**
+ * @brief Throws away everything still waiting, used when the host goes away.
+ * Counters are kept.
+ */
+void clearHIDLanes(struct HIDLanes *lanes) {
+    struct HIDEvent event;
+    for (int i = 0; i < HID_INSTANCE_TOTAL; i++) {
+        while (queue_try_remove(&lanes->ordered[i], &event));
+        lanes->inflight[i] = false;
+    }
+    lanes->motion_head = 0;
+    lanes->motion_count = 0;
+    lanes->mouse_keys = 0;
+}
+
+static bool isOlder(uint32_t seq, uint32_t than) {
+    return (int32_t) (seq - than) < 0;
+}
+
+/**
+ * @brief Returns the HID interface an event is sent on.
+ */
+uint8_t hidInstance(struct HIDEvent *event) {
+    switch (event->type) {
+        case EVENT_MOUSE:
+        case EVENT_GAMEPAD:
+            return HID_INSTANCE_POINTER;
+        default:
+            return HID_INSTANCE_KEYBOARD;
+    }
+}
+
+static bool isOrdered(struct HIDLanes *lanes, struct HIDEvent *event) {
+    switch (event->type) {
+        case EVENT_KEYBOARD:
+        case EVENT_CONSUMER:
+            return true;
+        case EVENT_MOUSE:
+            return event->mouse_data.keys != lanes->mouse_keys;
+        case EVENT_GAMEPAD:
+            return false;
+    }
+    return true;
+}
+
+static bool addClamped(uint8_t *total, uint8_t amount) {
+    int16_t sum = (int8_t) *total + (int8_t) amount;
+    if (sum > 127 || sum < -127) {
+        return false;
+    }
+    *total = (uint8_t) sum;
+    return true;
+}
+
+/**
+ * @brief Folds a motion event into an older one of the same type.
+ * Relative mouse motion is summed, absolute gamepad positions are replaced.
+ *
+ * @return `true` when merged, `false` if the result doesn't fit a report
+ */
+static bool mergeMotion(struct HIDEvent *into, struct HIDEvent *event) {
+    if (into->type != event->type) {
+        return false;
+    }
+
+    switch (event->type) {
+        case EVENT_MOUSE: {
+            struct MouseEvent merged = into->mouse_data;
+            if (merged.keys != event->mouse_data.keys
+                    || !addClamped(&merged.x, event->mouse_data.x)
+                    || !addClamped(&merged.y, event->mouse_data.y)
+                    || !addClamped(&merged.wheel, event->mouse_data.wheel)
+                    || !addClamped(&merged.pan, event->mouse_data.pan)) {
+                return false;
+            }
+            into->mouse_data = merged;
+            return true;
+        }
+        case EVENT_GAMEPAD:
+            into->gamepad_data = event->gamepad_data;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Adds an event to the lane it belongs to.
+ *
+ * @param lanes The lanes to add the event to
+ * @param event The event, its sequence number is filled in
+ * @return `true` when the event was queued or merged, `false` when it was rejected
+ */
+bool addHIDEvent(struct HIDLanes *lanes, struct HIDEvent *event) {
+    if (isOrdered(lanes, event)) {
+        event->seq = lanes->next_seq;
+        if (!queue_try_add(&lanes->ordered[hidInstance(event)], event)) {
+            lanes->ordered_full++;
+            return false;
+        }
+        lanes->next_seq++;
+        if (hidInstance(event) == HID_INSTANCE_POINTER) {
+            lanes->last_ordered_seq = event->seq;
+        }
+        if (event->type == EVENT_MOUSE) {
+            lanes->mouse_keys = event->mouse_data.keys;
+        }
+        return true;
+    }
+
+    // Only the newest motion entry can take a merge, and only if no ordered pointer
+    // event was queued after it, otherwise the motion would move before it
+    struct HIDEvent *tail = NULL;
+    if (lanes->motion_count > 0) {
+        tail = &lanes->motion[(lanes->motion_head + lanes->motion_count - 1) % MOTION_LANE_SIZE];
+        if (isOlder(tail->seq, lanes->last_ordered_seq)) {
+            tail = NULL;
+        }
+    }
+
+    // Absolute positions are stale as soon as a newer one exists, so always merge those.
+    // Relative motion is only merged once the lane is full.
+    if (tail != NULL && (event->type == EVENT_GAMEPAD || lanes->motion_count == MOTION_LANE_SIZE)) {
+        if (mergeMotion(tail, event)) {
+            lanes->motion_merged++;
+            return true;
+        }
+    }
+
+    if (lanes->motion_count == MOTION_LANE_SIZE) {
+        lanes->motion_dropped++;
+        return false;
+    }
+
+    event->seq = lanes->next_seq++;
+    lanes->motion[(lanes->motion_head + lanes->motion_count) % MOTION_LANE_SIZE] = *event;
+    lanes->motion_count++;
+    return true;
+}
+
+/**
+ * @brief Checks that a group of ordered events will fit, so e.g. a press and its release are queued together.
+ *
+ * @param instance HID interface the events are for
+ * @param count Number of ordered events about to be added
+ * @return `true` when there is room for all of them
+ */
+bool reserveOrdered(struct HIDLanes *lanes, uint8_t instance, uint8_t count) {
+    if (ORDERED_LANE_SIZE - queue_get_level(&lanes->ordered[instance]) < count) {
+        lanes->ordered_full++;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks whether an ordered event still has to wait for an older ordered event on another interface.
+ * An older event blocks while it is queued, or while its interface hasn't finished sending it.
+ */
+static bool orderedBlocked(struct HIDLanes *lanes, uint8_t instance, uint32_t seq) {
+    struct HIDEvent head;
+
+    for (uint8_t i = 0; i < HID_INSTANCE_TOTAL; i++) {
+        if (i == instance) {
+            continue;
+        }
+        if (queue_try_peek(&lanes->ordered[i], &head) && isOlder(head.seq, seq)) {
+            return true;
+        }
+        if (lanes->inflight[i] && isOlder(lanes->inflight_seq[i], seq)) {
+            if (!tud_hid_n_ready(i)) {
+                return true;
+            }
+            lanes->inflight[i] = false;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Finds the next event to send on a HID interface without removing it.
+ * The ordered lane goes first unless the motion lane holds something older.
+ *
+ * @param from_motion Set to whether the event is the head of the motion lane
+ * @return `true` when there is an event, `false` if there is nothing to send yet
+ */
+static bool pickHIDEvent(struct HIDLanes *lanes, uint8_t instance, struct HIDEvent *event, bool *from_motion) {
+    struct HIDEvent ordered;
+    bool have_ordered = queue_try_peek(&lanes->ordered[instance], &ordered);
+
+    if (instance == HID_INSTANCE_POINTER && lanes->motion_count > 0) {
+        struct HIDEvent *motion = &lanes->motion[lanes->motion_head];
+        if (!have_ordered || isOlder(motion->seq, ordered.seq)) {
+            *event = *motion;
+            *from_motion = true;
+            return true;
+        }
+    }
+
+    if (!have_ordered || orderedBlocked(lanes, instance, ordered.seq)) {
+        return false;
+    }
+
+    *event = ordered;
+    *from_motion = false;
+    return true;
+}
+
+/**
+ * @brief Gets the next event to send on a HID interface, leaving it in its lane.
+ * Take it with takeHIDEvent once it was sent, so a failed send is retried instead of lost.
+ *
+ * @param instance HID interface about to send
+ * @return `true` when there is an event, `false` if there is nothing to send yet
+ */
+bool peekHIDEvent(struct HIDLanes *lanes, uint8_t instance, struct HIDEvent *event) {
+    bool from_motion;
+    return pickHIDEvent(lanes, instance, event, &from_motion);
+}
+
+/**
+ * @brief Takes the next event to send on a HID interface, call only when the interface is ready.
+ *
+ * @param instance HID interface about to send
+ * @return `true` when an event was removed, `false` if there is nothing to send yet
+ */
+bool takeHIDEvent(struct HIDLanes *lanes, uint8_t instance, struct HIDEvent *event) {
+    bool from_motion;
+
+    if (!pickHIDEvent(lanes, instance, event, &from_motion)) {
+        return false;
+    }
+
+    if (from_motion) {
+        lanes->motion_head = (lanes->motion_head + 1) % MOTION_LANE_SIZE;
+        lanes->motion_count--;
+        // The interface was ready, so whatever was in flight on it is done
+        lanes->inflight[instance] = false;
+    } else {
+        queue_try_remove(&lanes->ordered[instance], event);
+        lanes->inflight[instance] = true;
+        lanes->inflight_seq[instance] = event->seq;
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the lane counters to CDC.
+ */
+void reportHIDLanes(struct HIDLanes *lanes) {
+    char message[64];
+
+    snprintf(message, 64, "ordered: %lu/%lu queued  %lu full",
+             (unsigned long) queue_get_level(&lanes->ordered[HID_INSTANCE_KEYBOARD]),
+             (unsigned long) queue_get_level(&lanes->ordered[HID_INSTANCE_POINTER]),
+             (unsigned long) lanes->ordered_full);
+    logLine(message);
+    snprintf(message, 64, "motion: %u queued  %lu merged  %lu dropped",
+             lanes->motion_count, (unsigned long) lanes->motion_merged, (unsigned long) lanes->motion_dropped);
+    logLine(message);
+}
@@ -0,0 +1,144 @@
+#include "macro.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+static const struct Macro *playing = NULL;
+static uint8_t step;
+// Last keyboard state from the lanes, macro steps wait until it is released
+static struct KeyboardEvent base;
+// Keys of the last macro step sent, kept held under lane keyboard reports
+static struct KeyboardEvent held;
+
+// Counters
+static uint32_t macros_played;
+static uint32_t macros_rejected;
+
+/**
+ * @brief Adds the modifiers and keys of one keyboard state to another.
+ * Keys that don't fit the 6 key slots are left out.
+ */
+static void combineKeys(struct KeyboardEvent *into, const struct KeyboardEvent *with) {
+    into->modifiers |= with->modifiers;
+    for (int i = 0; i < 6; i++) {
+        uint8_t key = with->keys[i];
+        if (key == 0 || memchr(into->keys, key, 6) != NULL) {
+            continue;
+        }
+        uint8_t *slot = memchr(into->keys, 0, 6);
+        if (slot != NULL) {
+            *slot = key;
+        }
+    }
+}
+
+/**
+ * @brief Starts playing a macro, steps are sent from the main loop as fast as the keyboard interface takes them.
+ *
+ * @param macro The macro to play
+ * @return `true` when started, `false` if another macro is still playing
+ */
+bool playMacro(const struct Macro *macro) {
+    if (macro == NULL || macro->count == 0) {
+        return false;
+    }
+    if (playing != NULL) {
+        macros_rejected++;
+        return false;
+    }
+    macros_played++;
+    playing = macro;
+    step = 0;
+    return true;
+}
+
+/**
+ * @brief Drops the playing macro, used when the host goes away.
+ */
+void stopMacro(void) {
+    playing = NULL;
+    memset(&base, 0, sizeof(base));
+    memset(&held, 0, sizeof(held));
+}
+
+/**
+ * @brief Gets the next report of the playing macro.
+ * Steps are sent exactly as written, so a step waits while the lanes hold any key,
+ * e.g. the CTRL of a pan, instead of going out with that key added. After the last
+ * step an empty report releases whatever the macro was still holding.
+ *
+ * @param event Filled with the next report
+ * @return `true` when there is a report to send, `false` if no macro is playing or it has to wait
+ */
+bool nextMacroEvent(struct HIDEvent *event) {
+    static const struct KeyboardEvent released;
+
+    if (playing == NULL || memcmp(&base, &released, sizeof(base)) != 0) {
+        return false;
+    }
+
+    memset(event, 0, sizeof(*event));
+    if (step == playing->count) {
+        event->type = EVENT_KEYBOARD;
+        return true;
+    }
+
+    const struct MacroStep *cur = &playing->steps[step];
+    switch (cur->type) {
+        case MACRO_KEYBOARD:
+            event->type = EVENT_KEYBOARD;
+            event->keyboard_data.modifiers = cur->modifiers;
+            memcpy(event->keyboard_data.keys, cur->keys, sizeof(cur->keys));
+            break;
+        case MACRO_CONSUMER:
+            event->type = EVENT_CONSUMER;
+            event->consumer_data.usage = cur->usage;
+            break;
+    }
+    return true;
+}
+
+/**
+ * @brief Moves on once the report from nextMacroEvent was handed to the interface.
+ */
+void advanceMacro(void) {
+    if (playing == NULL) {
+        return;
+    }
+    if (step < playing->count) {
+        const struct MacroStep *cur = &playing->steps[step];
+        if (cur->type == MACRO_KEYBOARD) {
+            held.modifiers = cur->modifiers;
+            memcpy(held.keys, cur->keys, sizeof(held.keys));
+        }
+        step++;
+    } else {
+        playing = NULL;
+        memset(&held, 0, sizeof(held));
+    }
+}
+
+/**
+ * @brief Takes a keyboard state from the lanes.
+ * Macro steps wait until it is released again, and the keys the playing macro holds
+ * are added to it, so a lane report doesn't release them between a press and its release.
+ *
+ * @param keyboard Keyboard state taken from the lanes, updated with the macro's keys
+ */
+void setMacroBase(struct KeyboardEvent *keyboard) {
+    base = *keyboard;
+    if (playing != NULL) {
+        combineKeys(keyboard, &held);
+    }
+}
+
+/**
+ * @brief Writes the macro counters to CDC.
+ */
+void reportMacros(void) {
+    char message[64];
+
+    snprintf(message, 64, "macro: %lu played  %lu rejected",
+             (unsigned long) macros_played, (unsigned long) macros_rejected);
+    logLine(message);
+}
@@ -0,0 +1,186 @@
+#include "reports.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "usb_descriptors.h"
+
+static const uint8_t report_len[REPORT_ID_COUNT] = {
+    [REPORT_ID_KEYBOARD] = sizeof(hid_keyboard_report_t),
+    [REPORT_ID_MOUSE] = sizeof(hid_mouse_report_t),
+    [REPORT_ID_CONSUMER_CONTROL] = sizeof(uint16_t),
+    [REPORT_ID_GAMEPAD] = sizeof(hid_stick_report_t)
+};
+
+static const char* report_names[REPORT_ID_COUNT] = {
+    [REPORT_ID_KEYBOARD] = "keyboard",
+    [REPORT_ID_MOUSE] = "mouse",
+    [REPORT_ID_CONSUMER_CONTROL] = "consumer",
+    [REPORT_ID_GAMEPAD] = "gamepad"
+};
+
+// Last state the host has for every report ID. Relative mouse motion is
+// stored as 0, so this is also exactly what an idle repeat sends.
+static uint8_t shadow[REPORT_ID_COUNT][CFG_TUD_HID_EP_BUFSIZE];
+static uint32_t sent_ms[REPORT_ID_COUNT];
+// SET_IDLE rate per interface, in 4 ms units. 0 = only report on change
+static uint8_t idle_rate[HID_INSTANCE_TOTAL];
+
+// Counters
+static uint32_t suppressed[REPORT_ID_COUNT];
+static uint32_t idle_repeats;
+
+static uint8_t reportInstance(uint8_t report_id) {
+    return (report_id == REPORT_ID_MOUSE || report_id == REPORT_ID_GAMEPAD) ? HID_INSTANCE_POINTER : HID_INSTANCE_KEYBOARD;
+}
+
+/**
+ * @brief Forgets what was sent, used when the host (re)starts from all released.
+ * Counters are kept.
+ */
+void resetReports(void) {
+    uint32_t cur_ms = to_ms_since_boot(get_absolute_time());
+
+    memset(shadow, 0, sizeof(shadow));
+    for (int i = 0; i < REPORT_ID_COUNT; i++) {
+        sent_ms[i] = cur_ms;
+    }
+    for (int i = 0; i < HID_INSTANCE_TOTAL; i++) {
+        idle_rate[i] = 0;
+    }
+}
+
+/**
+ * @brief Turns an event into its report and sends it, unless the host already has that state.
+ * Reports with relative motion are never redundant, for those only the buttons are compared.
+ *
+ * @param instance HID interface to send on, must be ready
+ * @param event The event to send
+ * @return SUBMIT_SENT when a report was sent, SUBMIT_SUPPRESSED when the host already had it,
+ *         SUBMIT_FAILED when the interface didn't take it and the event has to be sent again
+ */
+enum SUBMIT_RESULTS submitHIDEvent(uint8_t instance, struct HIDEvent *event) {
+    uint8_t report[CFG_TUD_HID_EP_BUFSIZE];
+    uint8_t report_id;
+    bool moved = false;
+
+    switch (event->type) {
+        case EVENT_KEYBOARD: {
+            hid_keyboard_report_t k_report = {
+                .modifier = event->keyboard_data.modifiers,
+                .reserved = 0
+            };
+            memcpy(k_report.keycode, event->keyboard_data.keys, sizeof(k_report.keycode));
+            report_id = REPORT_ID_KEYBOARD;
+            memcpy(report, &k_report, sizeof(k_report));
+            break;
+        }
+        case EVENT_MOUSE: {
+            hid_mouse_report_t m_report = {
+                .buttons = event->mouse_data.keys,
+                .x = event->mouse_data.x,
+                .y = event->mouse_data.y,
+                .wheel = event->mouse_data.wheel,
+                .pan = event->mouse_data.pan
+            };
+            moved = m_report.x != 0 || m_report.y != 0 || m_report.wheel != 0 || m_report.pan != 0;
+            report_id = REPORT_ID_MOUSE;
+            memcpy(report, &m_report, sizeof(m_report));
+            break;
+        }
+        case EVENT_GAMEPAD: {
+            hid_stick_report_t g_report = {
+                .x = event->gamepad_data.x,
+                .y = event->gamepad_data.y
+            };
+            report_id = REPORT_ID_GAMEPAD;
+            memcpy(report, &g_report, sizeof(g_report));
+            break;
+        }
+        case EVENT_CONSUMER:
+            report_id = REPORT_ID_CONSUMER_CONTROL;
+            memcpy(report, &event->consumer_data.usage, sizeof(uint16_t));
+            break;
+        default:
+            // Nothing the host could be sent, retrying would only hold up the lane
+            return SUBMIT_SUPPRESSED;
+    }
+
+    if (!moved && memcmp(report, shadow[report_id], report_len[report_id]) == 0) {
+        suppressed[report_id]++;
+        return SUBMIT_SUPPRESSED;
+    }
+
+    if (!tud_hid_n_report(instance, report_id, report, report_len[report_id])) {
+        return SUBMIT_FAILED;
+    }
+
+    memcpy(shadow[report_id], report, report_len[report_id]);
+    if (report_id == REPORT_ID_MOUSE) {
+        // Keep the buttons, drop the motion
+        memset(&shadow[report_id][1], 0, report_len[report_id] - 1);
+    }
+    sent_ms[report_id] = to_ms_since_boot(get_absolute_time());
+    return SUBMIT_SENT;
+}
+
+/**
+ * @brief Re-sends the last state of a report once the host's idle period has passed without a report.
+ * Sends at most one report, call only when the interface is ready and has nothing else to send.
+ *
+ * @return `true` when a report was repeated
+ */
+bool repeatIdleReports(uint8_t instance) {
+    if (idle_rate[instance] == 0) {
+        return false;
+    }
+
+    uint32_t cur_ms = to_ms_since_boot(get_absolute_time());
+    for (uint8_t id = 1; id < REPORT_ID_COUNT; id++) {
+        if (reportInstance(id) != instance || cur_ms - sent_ms[id] < idle_rate[instance] * 4u) {
+            continue;
+        }
+        if (tud_hid_n_report(instance, id, shadow[id], report_len[id])) {
+            sent_ms[id] = cur_ms;
+            idle_repeats++;
+            return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+void setIdleRate(uint8_t instance, uint8_t rate) {
+    if (instance < HID_INSTANCE_TOTAL) {
+        idle_rate[instance] = rate;
+    }
+}
+
+/**
+ * @brief Copies the last state of a report, for GET_REPORT(Input).
+ *
+ * @param instance HID interface the request came in on
+ * @return Length of the report, 0 for a report ID that interface doesn't have
+ */
+uint16_t getShadowReport(uint8_t instance, uint8_t report_id, uint8_t *buffer, uint16_t reqlen) {
+    if (report_id == 0 || report_id >= REPORT_ID_COUNT || reportInstance(report_id) != instance
+            || reqlen < report_len[report_id]) {
+        return 0;
+    }
+    memcpy(buffer, shadow[report_id], report_len[report_id]);
+    return report_len[report_id];
+}
+
+/**
+ * @brief Writes the suppression counters to CDC.
+ */
+void reportHIDReports(void) {
+    char message[64];
+
+    for (uint8_t id = 1; id < REPORT_ID_COUNT; id++) {
+        snprintf(message, 64, "%s: %lu suppressed", report_names[id], (unsigned long) suppressed[id]);
+        logLine(message);
+    }
+    snprintf(message, 64, "idle: %lu repeated", (unsigned long) idle_repeats);
+    logLine(message);
+}
@@ -1,34 +1,40 @@
 #include "utils.h"
+#include "lanes.h"
 #include "pico/stdlib.h"
 #include "pico/util/queue.h"
 #include "tusb.h"
 #include "hardware/adc.h"
 
 /**
- * @brief Sends a mouse event to the queue to be processed later in event loop.
+ * @brief Sends a mouse event to the lanes to be processed later in event loop.
+ * Events that change the mouse buttons go through the ordered lane and are never dropped.
  * https://wiki.osdev.org/USB_Human_Interface_Devices
  * 
- * @param queue The queue to add the Mouse event too
+ * @param lanes The lanes to add the Mouse event too
  * @param keys A bitfield of mouse keys.
  * @param x Amount to move mouse in x direction
  * @param y Amount to move mouse in y direction
- * @return `true` when item successfully added to queue, `false` otherwise
+ * @param wheel Amount to scroll the vertical wheel
+ * @param pan Amount to scroll the horizontal wheel
+ * @return `true` when item successfully added to the lanes, `false` otherwise
  */
-bool sendMouseEvent(queue_t *queue, uint8_t keys, uint8_t x, uint8_t y) {
+bool sendMouseEvent(struct HIDLanes *lanes, uint8_t keys, uint8_t x, uint8_t y, uint8_t wheel, uint8_t pan) {
     struct HIDEvent data = {
         .type = EVENT_MOUSE,
         .mouse_data = {
             .keys = keys,
             .x = x,
-            .y = y
+            .y = y,
+            .wheel = wheel,
+            .pan = pan
         },
         .keyboard_data = { 0 }
             
     };
-    return queue_try_add(queue, &data);
+    return addHIDEvent(lanes, &data);
 }
 
-bool sendKeyboardEvent(queue_t *queue, uint8_t modifiers, uint8_t keys[6]) {
+bool sendKeyboardEvent(struct HIDLanes *lanes, uint8_t modifiers, uint8_t keys[6]) {
     struct HIDEvent data = {
         .type = EVENT_KEYBOARD,
         .mouse_data = { 0 },
@@ -38,7 +44,26 @@ bool sendKeyboardEvent(queue_t *queue, uint8_t modifiers, uint8_t keys[6]) {
         }
     };
     memcpy(data.keyboard_data.keys, keys, 6*sizeof(*keys));
-    return queue_try_add(queue, &data);
+    return addHIDEvent(lanes, &data);
+}
+
+/**
+ * @brief Sends an absolute gamepad position to the lanes to be processed later in event loop.
+ *
+ * @param lanes The lanes to add the Gamepad event too
+ * @param x Absolute x position, [-2048, 2047]
+ * @param y Absolute y position, [-2048, 2047]
+ * @return `true` when item successfully added to the lanes, `false` otherwise
+ */
+bool sendGamepadEvent(struct HIDLanes *lanes, int16_t x, int16_t y) {
+    struct HIDEvent data = {
+        .type = EVENT_GAMEPAD,
+        .gamepad_data = {
+            .x = x,
+            .y = y
+        }
+    };
+    return addHIDEvent(lanes, &data);
 }
 
 inline void logMessage(char* str) {
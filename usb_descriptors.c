@@ -30,11 +30,14 @@
  * Same VID/PID with different interface e.g MSC (first), then CDC (later) will possibly cause system error on PC.
  *
  * Auto ProductID layout's Bitmap:
- *   [MSB]         HID | MSC | CDC          [LSB]
+ *   [MSB]  HID split | VENDOR | MIDI | HID | MSC | CDC          [LSB]
+ *
+ * Each class only gets one bit, so the map is clamped to whether the class is present.
+ * Splitting keyboard and pointer into two HID interfaces is its own bit.
  */
-#define _PID_MAP(itf, n)  ( (CFG_TUD_##itf) << (n) )
+#define _PID_MAP(itf, n)  ( (CFG_TUD_##itf > 0) << (n) )
 #define USB_PID           (0x4000 | _PID_MAP(CDC, 0) | _PID_MAP(MSC, 1) | _PID_MAP(HID, 2) | \
-                           _PID_MAP(MIDI, 3) | _PID_MAP(VENDOR, 4) )
+                           _PID_MAP(MIDI, 3) | _PID_MAP(VENDOR, 4) | ((CFG_TUD_HID > 1) << 5) )
 
 #define USB_VID   0xCafe
 #define USB_BCD   0x0200
@@ -81,12 +84,16 @@ uint8_t const * tud_descriptor_device_cb(void)
 // HID Report Descriptor
 //--------------------------------------------------------------------+
 
-uint8_t const desc_hid_report[] =
+uint8_t const desc_hid_keyboard_report[] =
 {
   TUD_HID_REPORT_DESC_KEYBOARD( HID_REPORT_ID(REPORT_ID_KEYBOARD         )),
-  TUD_HID_REPORT_DESC_MOUSE   ( HID_REPORT_ID(REPORT_ID_MOUSE            )),
-  TUD_HID_REPORT_DESC_CONSUMER( HID_REPORT_ID(REPORT_ID_CONSUMER_CONTROL )),
-  TUD_HID_REPORT_DESC_GAMEPAD ( HID_REPORT_ID(REPORT_ID_GAMEPAD          ))
+  TUD_HID_REPORT_DESC_CONSUMER( HID_REPORT_ID(REPORT_ID_CONSUMER_CONTROL ))
+};
+
+uint8_t const desc_hid_pointer_report[] =
+{
+  TUD_HID_REPORT_DESC_MOUSE_HIRES( HID_REPORT_ID(REPORT_ID_MOUSE        )),
+  TUD_HID_REPORT_DESC_STICK   ( HID_REPORT_ID(REPORT_ID_GAMEPAD          ))
 };
 
 // Invoked when received GET HID REPORT DESCRIPTOR
@@ -94,8 +101,7 @@ uint8_t const desc_hid_report[] =
 // Descriptor contents must exist long enough for transfer to complete
 uint8_t const * tud_hid_descriptor_report_cb(uint8_t instance)
 {
-  (void) instance;
-  return desc_hid_report;
+  return (instance == HID_INSTANCE_POINTER) ? desc_hid_pointer_report : desc_hid_keyboard_report;
 }
 
 //--------------------------------------------------------------------+
@@ -104,15 +110,17 @@ uint8_t const * tud_hid_descriptor_report_cb(uint8_t instance)
 
 enum
 {
-  ITF_NUM_HID = 0,
+  ITF_NUM_HID_KEYBOARD = 0,
+  ITF_NUM_HID_POINTER,
   ITF_NUM_CDC_0,
   ITF_NUM_CDC_0_DATA,
   ITF_NUM_TOTAL
 };
 
-#define  CONFIG_TOTAL_LEN  (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN + TUD_CDC_DESC_LEN)
+#define  CONFIG_TOTAL_LEN  (TUD_CONFIG_DESC_LEN + 2*TUD_HID_DESC_LEN + TUD_CDC_DESC_LEN)
 
-#define EPNUM_HID   0x81
+#define EPNUM_HID_KEYBOARD  0x81
+#define EPNUM_HID_POINTER   0x82
 
 #define EPNUM_CDC_0_NOTIF   0x83
 #define EPNUM_CDC_0_OUT     0x02
@@ -124,7 +132,8 @@ uint8_t const desc_configuration[] =
   TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
 
   // Interface number, string index, protocol, report descriptor len, EP In address, size & polling interval
-  TUD_HID_DESCRIPTOR(ITF_NUM_HID, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID, CFG_TUD_HID_EP_BUFSIZE, 2),
+  TUD_HID_DESCRIPTOR(ITF_NUM_HID_KEYBOARD, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_keyboard_report), EPNUM_HID_KEYBOARD, CFG_TUD_HID_EP_BUFSIZE, 2),
+  TUD_HID_DESCRIPTOR(ITF_NUM_HID_POINTER, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_pointer_report), EPNUM_HID_POINTER, CFG_TUD_HID_EP_BUFSIZE, 2),
 
   #if TUD_OPT_HIGH_SPEED
     TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_0, 5, EPNUM_CDC_0_NOTIF, 8, EPNUM_CDC_0_OUT, EPNUM_CDC_0_IN, 512)
@@ -34,4 +34,126 @@ enum
   REPORT_ID_COUNT
 };
 
+// HID interfaces, each with its own endpoint
+//      Keyboard: Keyboard and Consumer Control reports
+//      Pointer: Mouse and Gamepad reports
+enum
+{
+  HID_INSTANCE_KEYBOARD = 0,
+  HID_INSTANCE_POINTER,
+  HID_INSTANCE_TOTAL
+};
+
+// Resolution Multiplier advertised for the wheel and pan axes. Once the host
+// enables it, every wheel count is 1/WHEEL_RES_MULTIPLIER of a detent.
+#define WHEEL_RES_MULTIPLIER  8
+
+// Generic Desktop usage, not named by TinyUSB
+#define HID_USAGE_DESKTOP_RES_MULTIPLIER  0x48
+
+// Mouse Report Descriptor Template with high resolution wheel and pan.
+// Input report is laid out like hid_mouse_report_t. Feature report is one byte,
+// with the wheel Resolution Multiplier in bits 0-1 and the pan one in bits 2-3.
+#define TUD_HID_REPORT_DESC_MOUSE_HIRES(...) \
+  HID_USAGE_PAGE ( HID_USAGE_PAGE_DESKTOP      )                   ,\
+  HID_USAGE      ( HID_USAGE_DESKTOP_MOUSE     )                   ,\
+  HID_COLLECTION ( HID_COLLECTION_APPLICATION  )                   ,\
+    /* Report ID if any */\
+    __VA_ARGS__ \
+    HID_USAGE      ( HID_USAGE_DESKTOP_POINTER )                   ,\
+    HID_COLLECTION ( HID_COLLECTION_PHYSICAL   )                   ,\
+      HID_USAGE_PAGE  ( HID_USAGE_PAGE_BUTTON  )                   ,\
+        HID_USAGE_MIN   ( 1                                      ) ,\
+        HID_USAGE_MAX   ( 5                                      ) ,\
+        HID_LOGICAL_MIN ( 0                                      ) ,\
+        HID_LOGICAL_MAX ( 1                                      ) ,\
+        /* Left, Right, Middle, Backward, Forward buttons */ \
+        HID_REPORT_COUNT( 5                                      ) ,\
+        HID_REPORT_SIZE ( 1                                      ) ,\
+        HID_INPUT       ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ) ,\
+        /* 3 bit padding */ \
+        HID_REPORT_COUNT( 1                                      ) ,\
+        HID_REPORT_SIZE ( 3                                      ) ,\
+        HID_INPUT       ( HID_CONSTANT                           ) ,\
+      HID_USAGE_PAGE  ( HID_USAGE_PAGE_DESKTOP )                   ,\
+        /* X, Y position [-127, 127] */ \
+        HID_USAGE       ( HID_USAGE_DESKTOP_X                    ) ,\
+        HID_USAGE       ( HID_USAGE_DESKTOP_Y                    ) ,\
+        HID_LOGICAL_MIN ( 0x81                                   ) ,\
+        HID_LOGICAL_MAX ( 0x7f                                   ) ,\
+        HID_REPORT_COUNT( 2                                      ) ,\
+        HID_REPORT_SIZE ( 8                                      ) ,\
+        HID_INPUT       ( HID_DATA | HID_VARIABLE | HID_RELATIVE ) ,\
+      HID_COLLECTION ( HID_COLLECTION_LOGICAL  )                   ,\
+        /* Wheel Resolution Multiplier [1, WHEEL_RES_MULTIPLIER] */ \
+        HID_USAGE       ( HID_USAGE_DESKTOP_RES_MULTIPLIER       ) ,\
+        HID_LOGICAL_MIN ( 0                                      ) ,\
+        HID_LOGICAL_MAX ( 1                                      ) ,\
+        HID_PHYSICAL_MIN( 1                                      ) ,\
+        HID_PHYSICAL_MAX( WHEEL_RES_MULTIPLIER                   ) ,\
+        HID_REPORT_COUNT( 1                                      ) ,\
+        HID_REPORT_SIZE ( 2                                      ) ,\
+        HID_FEATURE     ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ) ,\
+        /* Vertical wheel scroll [-127, 127] */ \
+        HID_USAGE       ( HID_USAGE_DESKTOP_WHEEL                ) ,\
+        HID_LOGICAL_MIN ( 0x81                                   ) ,\
+        HID_LOGICAL_MAX ( 0x7f                                   ) ,\
+        HID_PHYSICAL_MIN( 0                                      ) ,\
+        HID_PHYSICAL_MAX( 0                                      ) ,\
+        HID_REPORT_COUNT( 1                                      ) ,\
+        HID_REPORT_SIZE ( 8                                      ) ,\
+        HID_INPUT       ( HID_DATA | HID_VARIABLE | HID_RELATIVE ) ,\
+      HID_COLLECTION_END                                           ,\
+      HID_COLLECTION ( HID_COLLECTION_LOGICAL  )                   ,\
+        /* Pan Resolution Multiplier [1, WHEEL_RES_MULTIPLIER] */ \
+        HID_USAGE       ( HID_USAGE_DESKTOP_RES_MULTIPLIER       ) ,\
+        HID_LOGICAL_MIN ( 0                                      ) ,\
+        HID_LOGICAL_MAX ( 1                                      ) ,\
+        HID_PHYSICAL_MIN( 1                                      ) ,\
+        HID_PHYSICAL_MAX( WHEEL_RES_MULTIPLIER                   ) ,\
+        HID_REPORT_COUNT( 1                                      ) ,\
+        HID_REPORT_SIZE ( 2                                      ) ,\
+        HID_FEATURE     ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ) ,\
+        /* Horizontal wheel scroll [-127, 127] */ \
+        HID_USAGE_PAGE  ( HID_USAGE_PAGE_CONSUMER                ) ,\
+        HID_USAGE_N     ( HID_USAGE_CONSUMER_AC_PAN, 2           ) ,\
+        HID_LOGICAL_MIN ( 0x81                                   ) ,\
+        HID_LOGICAL_MAX ( 0x7f                                   ) ,\
+        HID_PHYSICAL_MIN( 0                                      ) ,\
+        HID_PHYSICAL_MAX( 0                                      ) ,\
+        HID_REPORT_COUNT( 1                                      ) ,\
+        HID_REPORT_SIZE ( 8                                      ) ,\
+        HID_INPUT       ( HID_DATA | HID_VARIABLE | HID_RELATIVE ) ,\
+      HID_COLLECTION_END                                           ,\
+      /* 4 bit feature padding */ \
+      HID_REPORT_COUNT( 1                                        ) ,\
+      HID_REPORT_SIZE ( 4                                        ) ,\
+      HID_FEATURE     ( HID_CONSTANT                             ) ,\
+    HID_COLLECTION_END                                             ,\
+  HID_COLLECTION_END \
+
+// Gamepad Report Descriptor Template with absolute X, Y at full ADC resolution
+#define TUD_HID_REPORT_DESC_STICK(...) \
+  HID_USAGE_PAGE ( HID_USAGE_PAGE_DESKTOP     )                 ,\
+  HID_USAGE      ( HID_USAGE_DESKTOP_GAMEPAD  )                 ,\
+  HID_COLLECTION ( HID_COLLECTION_APPLICATION )                 ,\
+    /* Report ID if any */\
+    __VA_ARGS__ \
+    /* X, Y absolute [-2048, 2047] */ \
+    HID_USAGE         ( HID_USAGE_DESKTOP_X                    ) ,\
+    HID_USAGE         ( HID_USAGE_DESKTOP_Y                    ) ,\
+    HID_LOGICAL_MIN_N ( -2048, 2                               ) ,\
+    HID_LOGICAL_MAX_N ( 2047, 2                                ) ,\
+    HID_REPORT_COUNT  ( 2                                      ) ,\
+    HID_REPORT_SIZE   ( 16                                     ) ,\
+    HID_INPUT         ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ) ,\
+  HID_COLLECTION_END \
+
+// Gamepad report matching TUD_HID_REPORT_DESC_STICK
+typedef struct TU_ATTR_PACKED
+{
+  int16_t x;
+  int16_t y;
+} hid_stick_report_t;
+
 #endif /* USB_DESCRIPTORS_H_ */